@@ -7,7 +7,15 @@
 #include <deque>
 #include <limits>
 #include <unordered_map>
+#include <algorithm>
+#include <string>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <functional>
 #include "dcel.hpp"
+#include "pieces.hpp"
+#include "predicates.hpp"
 
 using namespace std;
 
@@ -33,22 +41,15 @@ using namespace std;
 int side(Vertex *A, Vertex *B, Vertex *P)
 {
     const int RIGHT = 1, LEFT = -1, ZERO = 0;
-    // subtracting co-ordinates of Vertex A from
-    // B and P, to make A as origin
-    int ax = A->x, bx = B->x, px = P->x, ay = A->y, by = B->y, py = P->y;
-    bx -= ax;
-    by -= ay;
-    px -= ax;
-    py -= ay;
-
-    // Determining cross Product
-    double cross_product = bx * py - by * px;
-
-    // return RIGHT if cross product is positive
+
+    // Determining cross Product, exactly when it is close to zero
+    double cross_product = orient2d(A->x, A->y, B->x, B->y, P->x, P->y);
+
+    // return LEFT if cross product is positive
     if (cross_product > 0)
         return LEFT;
 
-    // return LEFT if cross product is negative
+    // return RIGHT if cross product is negative
     if (cross_product < 0)
         return RIGHT;
 
@@ -56,6 +57,20 @@ int side(Vertex *A, Vertex *B, Vertex *P)
     return ZERO;
 }
 
+/**
+ * @brief Signed area of the parallelogram spanned by AB and AP
+ *
+ * @param A start co-ordinate of the line
+ * @param B end co-ordinate of the line
+ * @param P the point to be checked
+ *
+ * @return positive if P is to the left of AB, negative if to the right, 0 if collinear
+ */
+double orient(Vertex *A, Vertex *B, Vertex *P)
+{
+    return orient2d(A->x, A->y, B->x, B->y, P->x, P->y);
+}
+
 /**
  * @brief This function checks whether the given point lies inside the given polygon or not
  *
@@ -100,42 +115,9 @@ bool isInside(Vertex *p, vector<Vertex *> polygon)
  */
 bool isAcute(Vertex *p1, Vertex *p2, Vertex *p3)
 {
-
-    double x1 = p1->x;
-    double y1 = p1->y;
-
-    double x2 = p2->x;
-    double y2 = p2->y;
-
-    double x3 = p3->x;
-    double y3 = p3->y;
-
-    if (y1 == y2 && y2 == y3)
-        return 1;
-    if (x1 == x2 && x2 == x3)
-        return 1;
-
-    x1 = x1 - x2;
-    y1 = y1 - y2;
-    x3 = x3 - x2;
-    y3 = y3 - y2;
-    double dot = x1 * x3 + y1 * y3;
-    double det = x1 * y3 - y1 * x3;
-
-    double result = atan2(det, dot);
-    // cout<<result<<endl;
-    double res = ((result < 0) ? (result * 180 / 3.141592) + 360
-                               : (result * 180 / 3.141592));
-
-    // cout<<cos(result)<<" ";
-
-    if (cos(result) == -1)
-        return 1;
-
-    if (res > 180)
-        return 0;
-    else
-        return 1;
+    // the angle from p2p1 to p2p3, measured anti-clockwise, is more than 180 degrees
+    // exactly when p3 is to the right of the line p2p1; collinear triples are not notches
+    return orient2d(p2->x, p2->y, p1->x, p1->y, p3->x, p3->y) >= 0;
 }
 
 /**
@@ -311,12 +293,89 @@ bool inSideRectangle(Vertex *p, vector<double> r)
 }
 
 /**
- * @brief The algorithm for decomposition of the given polygon into convex polygons
+ * @brief distance of point p from the segment ab
+ */
+double segmentDistance(Vertex *a, Vertex *b, Vertex *p)
+{
+    double dx = b->x - a->x, dy = b->y - a->y;
+    double len2 = dx * dx + dy * dy;
+    double t = len2 == 0 ? 0 : ((p->x - a->x) * dx + (p->y - a->y) * dy) / len2;
+    t = max(0.0, min(1.0, t));
+    return hypot(p->x - (a->x + t * dx), p->y - (a->y + t * dy));
+}
+
+/**
+ * @brief Measures how far a polygon is from being convex
+ *
+ * The convex hull is built with Andrew's monotone chain. The hull vertices appear in the same
+ * cyclic order along the polygon, so the vertices between two consecutive ones form a pocket
+ * under that hull edge; the result is the deepest pocket vertex. O(k log k) for k vertices.
+ *
+ * @param piece the given polygon
+ *
+ * @return maximum distance from the polygon to its convex hull, 0 if it is convex
+ */
+double concavity(vector<Vertex *> piece)
+{
+    int k = piece.size();
+    if (k < 4)
+        return 0;
+    vector<Vertex *> pts = piece;
+    sort(pts.begin(), pts.end(), [](Vertex *p, Vertex *q) { return p->x < q->x || (p->x == q->x && p->y < q->y); });
+    vector<Vertex *> hull(2 * k);
+    int h = 0;
+    for (int i = 0; i < k; i++)
+    {
+        while (h >= 2 && orient(hull[h - 2], hull[h - 1], pts[i]) <= 0)
+            h--;
+        hull[h++] = pts[i];
+    }
+    for (int i = k - 2, lower = h + 1; i >= 0; i--)
+    {
+        while (h >= lower && orient(hull[h - 2], hull[h - 1], pts[i]) <= 0)
+            h--;
+        hull[h++] = pts[i];
+    }
+    unordered_map<Vertex *, bool> onHull;
+    for (int i = 0; i < h - 1; i++)
+        onHull[hull[i]] = true;
+
+    int start = 0;
+    while (start < k && !onHull[piece[start]])
+        start++;
+    double worst = 0;
+    Vertex *lid = piece[start];
+    vector<Vertex *> pocket;
+    for (int j = 1; j <= k; j++)
+    {
+        Vertex *p = piece[(start + j) % k];
+        if (!onHull[p])
+        {
+            pocket.push_back(p);
+            continue;
+        }
+        for (int i = 0; i < pocket.size(); i++)
+            worst = max(worst, segmentDistance(lid, p, pocket[i]));
+        pocket.clear();
+        lid = p;
+    }
+    return worst;
+}
+
+/**
+ * @brief The algorithm for decomposition of the given polygon into convex polygons, handing out pieces as they are cut
+ *
+ * Every piece is passed to sink as soon as it is cut off, so the consumer can work while the rest
+ * of the polygon is still being decomposed. Only the last chain is kept between steps.
+ *
+ * With a concavity tolerance the remaining polygon is accepted as a piece as soon as its
+ * #concavity is within the tolerance, so shallow notches no longer force more cuts.
  *
  * @param poly The original polygon
- * @param ans List of all the polygons after the partition process
+ * @param sink called once for every piece, in the order they are cut
+ * @param tol largest allowed concavity of a piece, 0 for exact convex decomposition
  */
-void fun(DCEL poly, vector<vector<Vertex *> > &ans)
+void funStream(DCEL poly, const function<void(vector<Vertex *> &)> &sink, double tol = 0)
 {
     vector<Vertex *> nots = notches(poly.v);
 
@@ -324,9 +383,9 @@ void fun(DCEL poly, vector<vector<Vertex *> > &ans)
 
     Vertex *first = poly.v[0];
 
-    if (nots.size() == 0)
+    if (nots.size() == 0 || (tol > 0 && concavity(poly.v) <= tol))
     {
-        ans.push_back(poly.v);
+        sink(poly.v);
         return;
     }
 
@@ -335,7 +394,7 @@ void fun(DCEL poly, vector<vector<Vertex *> > &ans)
     vector<Vertex *> curr;
     vector<Vertex *> next;
 
-    vector<vector<Vertex *> > L(3000);
+    vector<vector<Vertex *> > L(1);
     int m = 1;
     L[0].push_back(poly.v[0]);
     int count = 0;
@@ -353,11 +412,18 @@ void fun(DCEL poly, vector<vector<Vertex *> > &ans)
                 count = 1;
             if (count == s)
             {
-                ans.push_back(poly.v);
+                sink(poly.v);
                 return;
             }
         }
         s = poly.v.size();
+        if (L.size() <= m)
+            L.resize(m + 1);
+        if (m != 1 && tol > 0 && concavity(poly.v) <= tol)
+        {
+            sink(poly.v);
+            return;
+        }
 
         // can change initialisation
         vector<Vertex *> temp;
@@ -432,7 +498,7 @@ void fun(DCEL poly, vector<vector<Vertex *> > &ans)
 
         else
         {
-            ans.push_back(L[m]);
+            sink(L[m]);
             cout << "Equal\n";
             return;
         }
@@ -441,7 +507,7 @@ void fun(DCEL poly, vector<vector<Vertex *> > &ans)
 
         if (L[m][L[m].size() - 1] != temp[2])
         {
-            ans.push_back(L[m]);
+            sink(L[m]);
 
             for (int i = 1; i < L[m].size() - 1; i++)
             {
@@ -464,10 +530,23 @@ void fun(DCEL poly, vector<vector<Vertex *> > &ans)
         if (ti >= maxi)
             maxi = t;
         cout << "The maximum size is" << maxi << "\n";
+        vector<Vertex *>().swap(L[m - 1]);
         m += 1;
     }
 }
 
+/**
+ * @brief The algorithm for decomposition of the given polygon into convex polygons
+ *
+ * @param poly The original polygon
+ * @param ans List of all the polygons after the partition process
+ * @param tol largest allowed concavity of a piece, 0 for exact convex decomposition
+ */
+void fun(DCEL poly, vector<vector<Vertex *> > &ans, double tol = 0)
+{
+    funStream(poly, [&ans](vector<Vertex *> &piece) { ans.push_back(piece); }, tol);
+}
+
 /**
  * @brief given a point and a polygon it returns the previous point in the polygon in clockwise order
  *
@@ -500,12 +579,14 @@ Vertex *Prev(Vertex *v, vector<Vertex *> poly)
  * The above partition process may sometimes produce partitions that contain inessential diagonals.
  * To prevent this after the partition process we call this merging funcion
  * which checks everyone of the diagonal in order whether it can be removed.
+ * With a concavity tolerance a diagonal is also removed if the merged piece is within it.
  *
  * @param ans List of all the polygons after the partition process
  * @param poly The original polygon
+ * @param tol largest allowed concavity of a merged piece, 0 to only merge into convex pieces
  */
 
-void merge(vector<vector<Vertex*> > &ans, DCEL poly){
+void merge(vector<vector<Vertex*> > &ans, DCEL poly, double tol = 0){
      
             
                 vector<pair<Vertex *, Vertex *> > LLE, temp; 
@@ -550,7 +631,8 @@ void merge(vector<vector<Vertex*> > &ans, DCEL poly){
                         }
                     }
 
-
+                    // a diagonal seen by only one piece is broken output, #validate reports it
+                    if(i1 == -1 || i2 == -1) continue;
 
                      unordered_map<Vertex*, int> m; 
                    for(int l=0; l<ans[i1].size(); l++){
@@ -570,7 +652,7 @@ void merge(vector<vector<Vertex*> > &ans, DCEL poly){
 
                    vector<Vertex*> ac = notches(inter);
 
-                   if(ac.size() == 0) {
+                   if(ac.size() == 0 || (tol > 0 && concavity(inter) <= tol)) {
                         if(i1>i2) {
                             ans.erase(ans.begin() + i1); 
                             ans.erase(ans.begin() + i2); 
@@ -617,59 +699,1510 @@ void merge(vector<vector<Vertex*> > &ans, DCEL poly){
      
 
 
-int main()
+/**
+ * @brief Removes inessential diagonals from a stream of pieces, as #merge does for a whole list
+ *
+ * A directed diagonal (a, b) of a piece is open until the piece with (b, a) arrives. At that point
+ * the two pieces are merged if the result is convex (or within the concavity tolerance), and the
+ * diagonal is never looked at again. A piece is passed on as soon as none of its diagonals are
+ * open, so only pieces that may still be merged are held back.
+ */
+class StreamMerger
 {
+public:
+    /**
+     * @param poly The original polygon
+     * @param out called once for every finished piece
+     * @param tol largest allowed concavity of a merged piece, 0 to only merge into convex pieces
+     */
+    StreamMerger(vector<Vertex *> &poly, const function<void(vector<Vertex *> &)> &out, double tol = 0)
+        : out(out), tol(tol), next(0)
+    {
+        for (int i = 0; i < poly.size(); i++)
+            succ[poly[i]] = poly[(i + 1) % poly.size()];
+    }
 
-    fstream file("inp.txt");
+    /**
+     * @brief takes the next piece cut by #funStream
+     */
+    void add(vector<Vertex *> piece)
+    {
+        int id = next++;
+        held[id] = piece;
+        pending[id] = 0;
+
+        vector<pair<Vertex *, Vertex *> > diagonals;
+        for (int j = 0; j < piece.size(); j++)
+        {
+            Vertex *a = piece[j], *b = piece[(j + 1) % piece.size()];
+            if (succ[a] != b)
+                diagonals.push_back(make_pair(a, b));
+        }
+
+        for (int d = 0; d < diagonals.size(); d++)
+        {
+            Vertex *a = diagonals[d].first, *b = diagonals[d].second;
+            map<pair<Vertex *, Vertex *>, int>::iterator it = open.find(make_pair(b, a));
+            if (it == open.end())
+            {
+                open[make_pair(a, b)] = id;
+                pending[id]++;
+                continue;
+            }
+            int q = it->second;
+            open.erase(it);
+            pending[q]--;
+
+            vector<Vertex *> joined = join(held[id], held[q], a, b);
+            if (notches(joined).size() == 0 || (tol > 0 && concavity(joined) <= tol))
+            {
+                // q is absorbed, its open diagonals now belong to this piece
+                held[id] = joined;
+                pending[id] += pending[q];
+                vector<Vertex *> &old = held[q];
+                for (int j = 0; j < old.size(); j++)
+                {
+                    it = open.find(make_pair(old[j], old[(j + 1) % old.size()]));
+                    if (it != open.end() && it->second == q)
+                        it->second = id;
+                }
+                held.erase(q);
+                pending.erase(q);
+            }
+            else if (pending[q] == 0)
+                release(q);
+        }
+        if (pending[id] == 0)
+            release(id);
+    }
+
+    /**
+     * @brief passes on every piece still held back, e.g. ones whose partner never arrived
+     */
+    void finish()
+    {
+        while (held.size() > 0)
+            release(held.begin()->first);
+        open.clear();
+    }
+
+private:
+    function<void(vector<Vertex *> &)> out;
+    double tol;
+    int next;
+    unordered_map<Vertex *, Vertex *> succ;       // input edges
+    map<int, vector<Vertex *> > held;             // pieces that may still be merged, by arrival
+    map<int, int> pending;                        // number of open diagonals of each held piece
+    map<pair<Vertex *, Vertex *>, int> open;      // open diagonal -> piece that has it
+
+    void release(int id)
+    {
+        out(held[id]);
+        held.erase(id);
+        pending.erase(id);
+    }
+
+    /**
+     * @brief glues p, which has the edge a->b, to q, which has b->a
+     */
+    static vector<Vertex *> join(vector<Vertex *> &p, vector<Vertex *> &q, Vertex *a, Vertex *b)
+    {
+        int ip = find(p.begin(), p.end(), a) - p.begin();
+        int iq = find(q.begin(), q.end(), b) - q.begin();
+        vector<Vertex *> res;
+        for (int t = 1; t <= p.size(); t++)
+            res.push_back(p[(ip + t) % p.size()]); // b ... a
+        for (int t = 2; t < q.size(); t++)
+            res.push_back(q[(iq + t) % q.size()]); // after a ... before b
+        return res;
+    }
+};
+
+/**
+ * @brief Twice the signed area of a polygon stored as contiguous co-ordinate arrays
+ *
+ * The loop has no branches so the compiler can vectorize it.
+ *
+ * @param x x co-ordinates of the polygon
+ * @param y y co-ordinates of the polygon
+ * @param n number of vertices
+ *
+ * @return twice the signed area, positive if the polygon is anti-clockwise
+ */
+double signedArea2(const double *x, const double *y, int n)
+{
+    double a = 0;
+    for (int i = 0; i < n - 1; i++)
+        a += x[i] * y[i + 1] - x[i + 1] * y[i];
+    if (n > 0)
+        a += x[n - 1] * y[0] - x[0] * y[n - 1];
+    return a;
+}
+
+/**
+ * @brief Checks if a polygon stored as contiguous co-ordinate arrays is strictly convex
+ *
+ * Every turn must have the sign of the orientation and no three consecutive vertices may be collinear.
+ * The turns are first computed in blocks, with the error bound of #orient2d, by a branch-free loop
+ * that GCC vectorizes at -O3; counting the uncertain ones vectorizes too where 64-bit
+ * integer vector compares exist (-msse4.2, -mavx2). Only if a turn is too close to call are the
+ * turns checked again with #orient2d.
+ *
+ * @param x x co-ordinates of the polygon
+ * @param y y co-ordinates of the polygon
+ * @param n number of vertices
+ * @param orientation +1 for anti-clockwise, -1 for clockwise
+ *
+ * @return true if the polygon is strictly convex
+ */
+bool strictlyConvex(const double *x, const double *y, int n, int orientation)
+{
+    if (n < 3)
+        return false;
+    // margins of a block of turns, counted with an integer sum since a floating point min
+    // reduction does not vectorize without -ffast-math
+    const int BLOCK = 64;
+    double margin[BLOCK];
+    double o = orientation;
+    long long uncertain = 0;
+    for (int from = 0; from < n - 2; from += BLOCK)
+    {
+        int len = min(BLOCK, n - 2 - from);
+        const double *bx = x + from, *by = y + from;
+        for (int i = 0; i < len; i++)
+        {
+            double detleft = (bx[i] - bx[i + 2]) * (by[i + 1] - by[i + 2]);
+            double detright = (by[i] - by[i + 2]) * (bx[i + 1] - bx[i + 2]);
+            margin[i] = (detleft - detright) * o - ORIENT_ERRBOUND * (fabs(detleft) + fabs(detright));
+        }
+        for (int i = 0; i < len; i++)
+            uncertain += margin[i] <= 0;
+    }
+    predicateCounter.calls += n - 2;
+    for (int i = n - 2; i < n; i++)
+        uncertain += orient2d(x[i], y[i], x[(i + 1) % n], y[(i + 1) % n], x[(i + 2) % n], y[(i + 2) % n]) * orientation <= 0;
+    if (uncertain == 0)
+        return true;
 
-    int n;
-    file >> n;
-    DCEL poly;
-    vector<Vertex *> inp;
     for (int i = 0; i < n; i++)
+        if (orient2d(x[i], y[i], x[(i + 1) % n], y[(i + 1) % n], x[(i + 2) % n], y[(i + 2) % n]) * orientation <= 0)
+            return false;
+    return true;
+}
+
+/**
+ * @brief a segment used by the sweep in #segmentsOverlap, stored left to right
+ */
+class SweepSegment
+{
+public:
+    Vertex *a, *b; // a is the lexicographically smaller end point
+    int id;
+};
+
+/**
+ * @brief lexicographic order on co-ordinates, the order in which the sweep line visits points
+ */
+bool pointLess(Vertex *p, Vertex *q)
+{
+    return p->x < q->x || (p->x == q->x && p->y < q->y);
+}
+
+bool samePoint(Vertex *p, Vertex *q)
+{
+    return p->x == q->x && p->y == q->y;
+}
+
+/**
+ * @brief checks if point p lies on the segment ab, given that the three are collinear
+ */
+bool onSegment(Vertex *a, Vertex *b, Vertex *p)
+{
+    return min(a->x, b->x) <= p->x && p->x <= max(a->x, b->x) && min(a->y, b->y) <= p->y && p->y <= max(a->y, b->y);
+}
+
+/**
+ * @brief checks if two segments meet anywhere other than at a common end point
+ *
+ * Two edges that share an end point are allowed to touch there, but not to overlap along a line.
+ *
+ * @return true if the segments intersect illegally
+ */
+bool segmentsClash(const SweepSegment &s, const SweepSegment &t)
+{
+    Vertex *shared = NULL, *sOther = NULL, *tOther = NULL;
+    if (samePoint(s.a, t.a))
+        shared = s.a, sOther = s.b, tOther = t.b;
+    else if (samePoint(s.a, t.b))
+        shared = s.a, sOther = s.b, tOther = t.a;
+    else if (samePoint(s.b, t.a))
+        shared = s.b, sOther = s.a, tOther = t.b;
+    else if (samePoint(s.b, t.b))
+        shared = s.b, sOther = s.a, tOther = t.a;
+    if (shared != NULL)
     {
-        double x, y;
-        file >> x >> y;
-        // cout<<x<<" "<<y<<endl;
-        // poly->addVertex
-        Vertex *p = new Vertex(x, y);
-        // p->x = x;
-        // p->y = y;
-        poly.addVertex(x, y);
-        inp.push_back(p);
+        if (samePoint(sOther, tOther))
+            return true; // the same segment twice
+        if (orient(shared, sOther, tOther) != 0)
+            return false;
+        // collinear: they overlap if both leave the shared point in the same direction
+        return (sOther->x - shared->x) * (tOther->x - shared->x) + (sOther->y - shared->y) * (tOther->y - shared->y) > 0;
     }
 
-    for (int i = 1; i < n; i++)
+    double d1 = orient(s.a, s.b, t.a), d2 = orient(s.a, s.b, t.b);
+    double d3 = orient(t.a, t.b, s.a), d4 = orient(t.a, t.b, s.b);
+    if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0)))
+        return true;
+    if (d1 == 0 && onSegment(s.a, s.b, t.a))
+        return true;
+    if (d2 == 0 && onSegment(s.a, s.b, t.b))
+        return true;
+    if (d3 == 0 && onSegment(t.a, t.b, s.a))
+        return true;
+    if (d4 == 0 && onSegment(t.a, t.b, s.b))
+        return true;
+    return false;
+}
+
+/**
+ * @brief current event point of a sweep, owned by #segmentsOverlap
+ */
+class SweepPosition
+{
+public:
+    double x, y;
+};
+
+/**
+ * @brief orders the segments crossing the sweep line from bottom to top
+ *
+ * Two segments are compared where the later of them starts, using the exact #orient2d of that
+ * start point against the other segment (and of its end point if the start lies on it, which
+ * orders segments leaving a common point by slope). Interpolating y at the sweep line instead
+ * rounds, and a vertex lying exactly on another segment could then be ordered past it. Vertical
+ * segments are cut at the current event point, read from the sweep that owns the set, so
+ * separate sweeps can run on different threads.
+ */
+class SweepOrder
+{
+public:
+    const SweepPosition *at;
+    SweepOrder(const SweepPosition *at) : at(at) {}
+    double yAt(const SweepSegment *s) const
     {
-        poly.addEdge(poly.v[i - 1]->x, poly.v[i - 1]->y, poly.v[i]->x, poly.v[i]->y);
+        return max(s->a->y, min(at->y, s->b->y));
     }
-    poly.addEdge(poly.v[n - 1]->x, poly.v[n - 1]->y, poly.v[0]->x, poly.v[0]->y);
+    /**
+     * @brief side of the point (x, y) relative to the non-vertical segment s, +1 above, -1 below
+     */
+    static int side(const SweepSegment *s, double x, double y)
+    {
+        double o = orient2d(s->a->x, s->a->y, s->b->x, s->b->y, x, y);
+        return (o > 0) - (o < 0);
+    }
+    /**
+     * @return +1 if s lies above t on the sweep line, -1 if below, 0 if they are collinear
+     */
+    int compare(const SweepSegment *s, const SweepSegment *t) const
+    {
+        bool sv = s->a->x == s->b->x, tv = t->a->x == t->b->x;
+        if (sv && tv)
+        {
+            double ys = yAt(s), yt = yAt(t);
+            return (ys > yt) - (ys < yt);
+        }
+        if (sv) // a vertical segment is steeper than any other through the same point
+            return side(t, s->a->x, yAt(s)) >= 0 ? 1 : -1;
+        if (tv)
+            return side(s, t->a->x, yAt(t)) >= 0 ? -1 : 1;
+        bool sLater = pointLess(t->a, s->a);
+        const SweepSegment *u = sLater ? s : t, *w = sLater ? t : s;
+        int c = side(w, u->a->x, u->a->y);
+        if (c == 0)
+            c = side(w, u->b->x, u->b->y);
+        return sLater ? c : -c;
+    }
+    bool operator()(const SweepSegment *s, const SweepSegment *t) const
+    {
+        int c = compare(s, t);
+        if (c != 0)
+            return c < 0;
+        return s->id < t->id;
+    }
+};
 
-    file.close();
-    vector<vector<Vertex *> > ans;
+/**
+ * @brief Shamos-Hoey sweep: checks in O(n log n) if any two of the segments intersect illegally
+ *
+ * Only segments that become neighbours on the sweep line are ever tested against each other.
+ *
+ * @param segs list of segments, end points given in any order
+ *
+ * @return true if two of the segments meet anywhere other than at a common end point
+ */
+bool segmentsOverlap(vector<SweepSegment> segs)
+{
+    vector<pair<Vertex *, int> > events; // (point, segment index), insertions are encoded as index, removals as ~index
+    for (int i = 0; i < segs.size(); i++)
+    {
+        if (pointLess(segs[i].b, segs[i].a))
+            swap(segs[i].a, segs[i].b);
+        segs[i].id = i;
+        events.push_back(make_pair(segs[i].a, i));
+        events.push_back(make_pair(segs[i].b, ~i));
+    }
+    // removals before insertions at the same point, so edges meeting end to end are never neighbours
+    sort(events.begin(), events.end(), [](const pair<Vertex *, int> &p, const pair<Vertex *, int> &q) {
+        if (!samePoint(p.first, q.first))
+            return pointLess(p.first, q.first);
+        return p.second < q.second;
+    });
+
+    typedef set<SweepSegment *, SweepOrder> Status;
+    SweepPosition at;
+    SweepOrder order(&at);
+    Status status(order);
+    vector<Status::iterator> where(segs.size());
+    for (int e = 0; e < events.size(); e++)
+    {
+        at.x = events[e].first->x;
+        at.y = events[e].first->y;
+        int i = events[e].second;
+        if (i >= 0)
+        {
+            Status::iterator it = status.insert(&segs[i]).first;
+            where[i] = it;
+            if (it != status.begin() && segmentsClash(**prev(it), segs[i]))
+                return true;
+            if (next(it) != status.end() && segmentsClash(**next(it), segs[i]))
+                return true;
+        }
+        else
+        {
+            Status::iterator it = where[~i];
+            if (it != status.begin() && next(it) != status.end() && segmentsClash(**prev(it), **next(it)))
+                return true;
+            status.erase(it);
+        }
+    }
+    return false;
+}
 
-    fun(poly, ans);
-    ofstream myfile;
-    myfile.open("Vertexs.txt");
-    for (int i = 0; i < ans.size(); i++)
+/**
+ * @brief result of #validate, ok is set only if every check passed
+ */
+class ValidationReport
+{
+public:
+    bool ok, convex, inputVerticesOnly, areaMatches, noOverlap, diagonalsShared;
+    double inputArea, piecesArea;
+    int pieces;
+    double worstConcavity; // largest #concavity of a piece, 0 if all are convex
+};
+
+/**
+ * @brief Checks that a decomposition produced by #fun or #merge is a valid convex partition of the polygon
+ *
+ * Runs in O(n log n) where n is the total number of piece vertices:
+ * - every piece is strictly convex (or within the concavity tolerance) and has the orientation of the input,
+ * - pieces use only vertices of the input polygon,
+ * - the areas of the pieces add up to the area of the input,
+ * - no two edges cross or overlap (checked by a sweep over all distinct edges and the input boundary),
+ * - every input edge is used by exactly one piece and every diagonal by exactly two pieces, once in each direction.
+ *
+ * @param ans List of all the polygons after the partition process
+ * @param poly The original polygon
+ * @param tol largest allowed concavity of a piece, 0 to require strict convexity
+ *
+ * @return a report with the result of each check
+ */
+ValidationReport validate(vector<vector<Vertex *> > &ans, DCEL poly, double tol = 0)
+{
+    ValidationReport r;
+    r.convex = r.inputVerticesOnly = r.areaMatches = r.noOverlap = r.diagonalsShared = true;
+    r.pieces = ans.size();
+    r.worstConcavity = 0;
+
+    int n = poly.v.size();
+    vector<double> px(n), py(n);
+    unordered_map<Vertex *, Vertex *> succ; // input edges, in input order
+    for (int i = 0; i < n; i++)
     {
-        cout << "vector" << endl;
+        px[i] = poly.v[i]->x;
+        py[i] = poly.v[i]->y;
+        succ[poly.v[i]] = poly.v[(i + 1) % n];
+    }
+    double a2 = signedArea2(px.data(), py.data(), n);
+    int orientation = a2 > 0 ? 1 : -1;
+    r.inputArea = fabs(a2) / 2;
+
+    // all piece co-ordinates in one contiguous block
+    vector<int> start(ans.size() + 1, 0);
+    for (int i = 0; i < ans.size(); i++)
+        start[i + 1] = start[i] + ans[i].size();
+    vector<double> xs(start[ans.size()]), ys(start[ans.size()]);
+    for (int i = 0; i < ans.size(); i++)
         for (int j = 0; j < ans[i].size(); j++)
         {
-            cout << ans[i][j]->x << " " << ans[i][j]->y << endl;
+            xs[start[i] + j] = ans[i][j]->x;
+            ys[start[i] + j] = ans[i][j]->y;
         }
-    }
 
+    double total = 0;
     for (int i = 0; i < ans.size(); i++)
     {
+        int k = ans[i].size();
+        double a = signedArea2(&xs[start[i]], &ys[start[i]], k) * orientation;
+        if (!strictlyConvex(&xs[start[i]], &ys[start[i]], k, orientation))
+        {
+            double c = concavity(ans[i]);
+            r.worstConcavity = max(r.worstConcavity, c);
+            if (tol <= 0 || c > tol || a <= 0)
+                r.convex = false;
+        }
+        total += a;
+    }
+    r.piecesArea = total / 2;
+    r.areaMatches = fabs(r.piecesArea - r.inputArea) <= 1e-9 * max(1.0, r.inputArea);
+
+    map<pair<Vertex *, Vertex *>, int> used; // directed edges of the pieces
+    for (int i = 0; i < ans.size(); i++)
         for (int j = 0; j < ans[i].size(); j++)
         {
-            myfile << ans[i][j]->x << " " << ans[i][j]->y << " " << ans[i][(j + 1) % ans[i].size()]->x << " " << ans[i][(j + 1) % ans[i].size()]->y << endl;
+            Vertex *a = ans[i][j], *b = ans[i][(j + 1) % ans[i].size()];
+            if (succ.find(a) == succ.end())
+                r.inputVerticesOnly = false;
+            used[make_pair(a, b)]++;
+        }
+
+    int boundary = 0;
+    vector<SweepSegment> segs;
+    for (auto &u : used)
+    {
+        Vertex *a = u.first.first, *b = u.first.second;
+        if (u.second != 1)
+            r.diagonalsShared = false;
+        if (succ.count(a) && succ[a] == b)
+        {
+            boundary++;
+            continue; // added with the input boundary below
         }
+        if (!used.count(make_pair(b, a)))
+            r.diagonalsShared = false;
+        if (a < b || !used.count(make_pair(b, a)))
+        {
+            SweepSegment s;
+            s.a = a;
+            s.b = b;
+            segs.push_back(s);
+        }
+    }
+    if (boundary != n)
+        r.diagonalsShared = false;
+    for (int i = 0; i < n; i++)
+    {
+        SweepSegment s;
+        s.a = poly.v[i];
+        s.b = poly.v[(i + 1) % n];
+        segs.push_back(s);
     }
+    r.noOverlap = !segmentsOverlap(segs);
 
-    // set<pair<Vertex*, Vertex*>> added;
+    r.ok = r.convex && r.inputVerticesOnly && r.areaMatches && r.noOverlap && r.diagonalsShared;
+    return r;
+}
+
+/**
+ * @brief prints a #ValidationReport
+ */
+void printReport(ValidationReport r)
+{
+    cout << "validation " << (r.ok ? "passed" : "FAILED") << endl;
+    cout << "  pieces                   " << r.pieces << endl;
+    cout << "  convex pieces            " << (r.convex ? "yes" : "no") << endl;
+    cout << "  worst concavity          " << r.worstConcavity << endl;
+    cout << "  only input vertices      " << (r.inputVerticesOnly ? "yes" : "no") << endl;
+    cout << "  area (input / pieces)    " << r.inputArea << " / " << r.piecesArea << endl;
+    cout << "  no overlapping edges     " << (r.noOverlap ? "yes" : "no") << endl;
+    cout << "  diagonals shared by two  " << (r.diagonalsShared ? "yes" : "no") << endl;
+}
+
+/**
+ * @brief prints how many orientation tests ran and how many were decided without exact arithmetic
+ */
+void printPredicateStats()
+{
+    unsigned long long calls, exact;
+    predicateStats(calls, exact);
+    cout << "orientation tests " << calls << ", filter hit rate " << (calls ? 100.0 * (calls - exact) / calls : 100.0) << "%" << endl;
+}
+
+/**
+ * @brief distance of point p from the line through a and b, or from a if a and b coincide
+ */
+double lineDistance(Vertex *a, Vertex *b, Vertex *p)
+{
+    double len = hypot(b->x - a->x, b->y - a->y);
+    if (len == 0)
+        return hypot(p->x - a->x, p->y - a->y);
+    return fabs(orient(a, b, p)) / len;
+}
+
+/**
+ * @brief checks if vertex b adds nothing to the chain a, b, c
+ *
+ * b is redundant if a, b, c are exactly collinear: either b lies on the segment ac, or the chain
+ * turns back at b and b is the tip of a zero area spike. Vertices that are only nearly collinear
+ * are left to #simplifyDP, which bounds the deviation of everything it removes.
+ */
+bool redundant(Vertex *a, Vertex *b, Vertex *c)
+{
+    return orient(a, b, c) == 0;
+}
+
+/**
+ * @brief Removes near duplicate, collinear and spike vertices from a polygon in a single linear pass
+ *
+ * Vertices are pushed on a stack; a vertex within tol of the top of the stack is merged into it
+ * and the top is popped while it is #redundant between the vertex below it and the new one.
+ * The seam between the last and first vertex is cleaned up at the end. Every merged vertex is
+ * within tol of the vertex it was merged into and every other removed vertex lies exactly on the
+ * simplified boundary, so the error does not build up along the outline. If merging makes the
+ * polygon self-intersect it is returned unchanged.
+ *
+ * @param poly the given polygon
+ * @param tol vertices closer than this are merged, use 0 to only remove exact duplicates and collinear vertices
+ * @param ids filled with the index in poly of every vertex that is kept
+ *
+ * @return the simplified polygon, never fewer than 3 vertices
+ */
+vector<Vertex *> simplify(vector<Vertex *> poly, double tol, vector<int> &ids)
+{
+    deque<int> st;
+    for (int i = 0; i < poly.size(); i++)
+    {
+        Vertex *p = poly[i];
+        if (st.size() > 0 && hypot(p->x - poly[st.back()]->x, p->y - poly[st.back()]->y) <= tol)
+            continue;
+        while (st.size() >= 2 && redundant(poly[st[st.size() - 2]], poly[st.back()], p))
+            st.pop_back();
+        st.push_back(i);
+    }
+
+    // the polygon is closed, so the first and last vertices need the same treatment
+    bool changed = true;
+    while (changed && st.size() > 3)
+    {
+        changed = false;
+        int n = st.size();
+        if (hypot(poly[st.back()]->x - poly[st[0]]->x, poly[st.back()]->y - poly[st[0]]->y) <= tol ||
+            redundant(poly[st[n - 2]], poly[st[n - 1]], poly[st[0]]))
+        {
+            st.pop_back();
+            changed = true;
+        }
+        else if (redundant(poly[st[n - 1]], poly[st[0]], poly[st[1]]))
+        {
+            st.pop_front();
+            changed = true;
+        }
+    }
+
+    vector<Vertex *> res;
+    for (int i = 0; i < st.size(); i++)
+        res.push_back(poly[st[i]]);
+    vector<SweepSegment> segs(res.size());
+    for (int i = 0; i < res.size(); i++)
+    {
+        segs[i].a = res[i];
+        segs[i].b = res[(i + 1) % res.size()];
+    }
+    if (res.size() < 3 || segmentsOverlap(segs))
+    {
+        ids.clear();
+        for (int i = 0; i < poly.size(); i++)
+            ids.push_back(i);
+        return poly;
+    }
+
+    ids.assign(st.begin(), st.end());
+    return res;
+}
+
+/**
+ * @brief Douglas-Peucker simplification of the chain poly[from..to], without recursion
+ *
+ * @param poly the given polygon
+ * @param from index of the first vertex of the chain
+ * @param to index of the last vertex of the chain, wraps around the end of poly
+ * @param tol largest allowed distance of a removed vertex from the simplified chain
+ * @param keep set to true for every vertex that is kept
+ */
+void douglasPeucker(vector<Vertex *> &poly, int from, int to, double tol, vector<bool> &keep)
+{
+    int n = poly.size();
+    if (to < from)
+        to += n;
+    vector<pair<int, int> > todo;
+    todo.push_back(make_pair(from, to));
+    while (todo.size() > 0)
+    {
+        pair<int, int> c = todo.back();
+        todo.pop_back();
+        int far = -1;
+        double best = tol;
+        for (int i = c.first + 1; i < c.second; i++)
+        {
+            double d = lineDistance(poly[c.first % n], poly[c.second % n], poly[i % n]);
+            if (d > best)
+            {
+                best = d;
+                far = i;
+            }
+        }
+        if (far == -1)
+            continue;
+        keep[far % n] = true;
+        todo.push_back(make_pair(c.first, far));
+        todo.push_back(make_pair(far, c.second));
+    }
+}
+
+/**
+ * @brief Topology preserving Douglas-Peucker simplification of a polygon
+ *
+ * The polygon is cut into two chains at vertex 0 and the vertex farthest from it, and each chain
+ * is simplified so that no removed vertex is more than tol away from the result. If the result
+ * is not a simple polygon the tolerance is halved and the simplification retried; after a few
+ * failures the polygon is returned unchanged.
+ *
+ * @param poly the given polygon
+ * @param tol maximum deviation of the simplified boundary
+ * @param ids index in poly of every vertex that is kept
+ *
+ * @return the simplified polygon
+ */
+vector<Vertex *> simplifyDP(vector<Vertex *> poly, double tol, vector<int> &ids)
+{
+    int n = poly.size();
+    int far = 0;
+    for (int i = 1; i < n; i++)
+        if (hypot(poly[i]->x - poly[0]->x, poly[i]->y - poly[0]->y) > hypot(poly[far]->x - poly[0]->x, poly[far]->y - poly[0]->y))
+            far = i;
+
+    for (int attempt = 0; attempt < 4 && far != 0; attempt++, tol /= 2)
+    {
+        vector<bool> keep(n, false);
+        keep[0] = keep[far] = true;
+        douglasPeucker(poly, 0, far, tol, keep);
+        douglasPeucker(poly, far, 0, tol, keep);
+
+        vector<int> kept;
+        for (int i = 0; i < n; i++)
+            if (keep[i])
+                kept.push_back(i);
+        if (kept.size() < 3)
+            continue;
+
+        vector<SweepSegment> segs(kept.size());
+        for (int i = 0; i < kept.size(); i++)
+        {
+            segs[i].a = poly[kept[i]];
+            segs[i].b = poly[kept[(i + 1) % kept.size()]];
+        }
+        if (segmentsOverlap(segs))
+            continue;
+
+        ids = kept;
+        vector<Vertex *> res;
+        for (int i = 0; i < kept.size(); i++)
+            res.push_back(poly[kept[i]]);
+        return res;
+    }
+
+    ids.clear();
+    for (int i = 0; i < n; i++)
+        ids.push_back(i);
+    return poly;
+}
+
+/**
+ * @brief rounds n up to a multiple of #PIECES_ALIGN
+ */
+uint64_t alignUp(uint64_t n)
+{
+    return (n + PIECES_ALIGN - 1) / PIECES_ALIGN * PIECES_ALIGN;
+}
+
+/**
+ * @brief Writes the pieces in the structure-of-arrays layout described in pieces.hpp
+ *
+ * Vertex co-ordinates, outward edge normals and bounding boxes are computed here once so the
+ * collision engine can mmap the file and use it without converting each piece.
+ *
+ * @param ans List of all the polygons after the partition process
+ * @param path the file to write
+ *
+ * @return false if the file could not be written
+ */
+bool exportPieces(vector<vector<Vertex *> > &ans, const char *path)
+{
+    uint64_t pieces = ans.size(), verts = 0;
+    for (int i = 0; i < ans.size(); i++)
+        verts += ans[i].size();
+
+    PiecesHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "CVXPIECE", 8);
+    h.version = PIECES_VERSION;
+    h.headerSize = sizeof(PiecesHeader);
+    h.pieceCount = pieces;
+    h.vertexCount = verts;
+    h.rangesOffset = alignUp(sizeof(PiecesHeader));
+    h.xOffset = alignUp(h.rangesOffset + pieces * sizeof(PieceRange));
+    h.yOffset = alignUp(h.xOffset + verts * sizeof(double));
+    h.nxOffset = alignUp(h.yOffset + verts * sizeof(double));
+    h.nyOffset = alignUp(h.nxOffset + verts * sizeof(double));
+    h.aabbOffset = alignUp(h.nyOffset + verts * sizeof(double));
+    h.fileSize = alignUp(h.aabbOffset + pieces * sizeof(PieceAABB));
+
+    vector<char> buf(h.fileSize, 0);
+    memcpy(&buf[0], &h, sizeof(h));
+    PieceRange *ranges = (PieceRange *)&buf[h.rangesOffset];
+    double *x = (double *)&buf[h.xOffset], *y = (double *)&buf[h.yOffset];
+    double *nx = (double *)&buf[h.nxOffset], *ny = (double *)&buf[h.nyOffset];
+    PieceAABB *aabb = (PieceAABB *)&buf[h.aabbOffset];
+
+    uint32_t first = 0;
+    for (int i = 0; i < ans.size(); i++)
+    {
+        int k = ans[i].size();
+        ranges[i].first = first;
+        ranges[i].count = k;
+        vector<double> r = rectangle(ans[i]);
+        aabb[i].minx = r[1];
+        aabb[i].miny = r[3];
+        aabb[i].maxx = r[0];
+        aabb[i].maxy = r[2];
+
+        for (int j = 0; j < k; j++)
+        {
+            x[first + j] = ans[i][j]->x;
+            y[first + j] = ans[i][j]->y;
+        }
+        // outward is to the left of a clockwise edge and to the right of an anti-clockwise one
+        double o = signedArea2(x + first, y + first, k) < 0 ? 1 : -1;
+        for (int j = 0; j < k; j++)
+        {
+            int l = first + (j + 1) % k;
+            double dx = x[l] - x[first + j], dy = y[l] - y[first + j];
+            double len = hypot(dx, dy);
+            if (len == 0)
+                len = 1;
+            nx[first + j] = -o * dy / len;
+            ny[first + j] = o * dx / len;
+        }
+        first += k;
+    }
+
+    ofstream out(path, ios::binary);
+    out.write(&buf[0], buf.size());
+    return out.good();
+}
+
+/**
+ * @brief checks if vertex j lies strictly inside the interior angle of the polygon at vertex i
+ *
+ * @param poly the given polygon
+ * @param i vertex whose angle is checked
+ * @param j the other end of the candidate diagonal
+ * @param o +1 if poly is anti-clockwise, -1 if clockwise
+ */
+bool inCone(vector<Vertex *> &poly, int i, int j, int o)
+{
+    int n = poly.size();
+    Vertex *a0 = poly[(i + n - 1) % n], *a = poly[i], *a1 = poly[(i + 1) % n], *b = poly[j];
+    if (o * orient(a0, a, a1) >= 0) // convex (or straight) vertex
+        return o * orient(a, b, a0) > 0 && o * orient(b, a, a1) > 0;
+    return !(o * orient(a, b, a1) >= 0 && o * orient(b, a, a0) >= 0);
+}
+
+/**
+ * @brief checks if the segment between vertices i and j is a diagonal lying inside the polygon
+ *
+ * O(n): the segment must leave both end points into the interior and must not touch any edge
+ * that is not incident to one of them.
+ */
+bool isDiagonal(vector<Vertex *> &poly, int i, int j, int o)
+{
+    int n = poly.size();
+    if (i == j || (i + 1) % n == j || (j + 1) % n == i)
+        return false;
+    if (!inCone(poly, i, j, o) || !inCone(poly, j, i, o))
+        return false;
+    SweepSegment d;
+    d.a = poly[i];
+    d.b = poly[j];
+    for (int k = 0; k < n; k++)
+    {
+        int l = (k + 1) % n;
+        if (k == i || k == j || l == i || l == j)
+            continue;
+        SweepSegment e;
+        e.a = poly[k];
+        e.b = poly[l];
+        if (segmentsClash(d, e))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief cuts a polygon along the diagonal between vertices i and j, both halves keep its ends
+ */
+void cutPolygon(vector<Vertex *> &poly, int i, int j, vector<Vertex *> &left, vector<Vertex *> &right)
+{
+    int n = poly.size();
+    left.clear();
+    right.clear();
+    for (int k = i; k != j; k = (k + 1) % n)
+        left.push_back(poly[k]);
+    left.push_back(poly[j]);
+    for (int k = j; k != i; k = (k + 1) % n)
+        right.push_back(poly[k]);
+    right.push_back(poly[i]);
+}
+
+/**
+ * @brief Cuts a polygon into two halves of about the same size along an internal diagonal
+ *
+ * Diagonals from 16 start vertices spread around the polygon to the 32 vertices opposite each of
+ * them are tried first, closest to an even split first; each try costs O(n). Opposite sides of
+ * jagged or fan shaped outlines often do not see each other, so if none of those 512 is a diagonal
+ * every vertex is scanned from up to 4 reflex vertices and the most even split found is used. A
+ * reflex vertex always sees some other vertex, so only convex polygons (and triangles) are not cut.
+ *
+ * @param poly the given polygon
+ * @param left first half, shares the diagonal with right
+ * @param right second half
+ *
+ * @return false if no diagonal was found
+ */
+bool splitPolygon(vector<Vertex *> &poly, vector<Vertex *> &left, vector<Vertex *> &right)
+{
+    int n = poly.size();
+    if (n < 4)
+        return false;
+    vector<double> x(n), y(n);
+    for (int i = 0; i < n; i++)
+    {
+        x[i] = poly[i]->x;
+        y[i] = poly[i]->y;
+    }
+    int o = signedArea2(x.data(), y.data(), n) > 0 ? 1 : -1;
+
+    const int starts = 16, offsets = 32;
+    for (int s = 0; s < starts; s++)
+    {
+        int i = (long long)s * n / starts;
+        for (int t = 0; t < offsets; t++)
+        {
+            // n/2, n/2+1, n/2-1, n/2+2, ...
+            int d = n / 2 + ((t % 2) ? (t + 1) / 2 : -(t / 2));
+            if (d < 2 || d > n - 2)
+                continue; // small polygons run out of opposite vertices
+            int j = (i + d) % n;
+            if (!isDiagonal(poly, i, j, o))
+                continue;
+            cutPolygon(poly, i, j, left, right);
+            return true;
+        }
+    }
+
+    // full scan, the first diagonal met going outwards from n/2 is the most even one from i
+    vector<int> reflex;
+    for (int i = 0; i < n; i++)
+        if (o * orient(poly[(i + n - 1) % n], poly[i], poly[(i + 1) % n]) < 0)
+            reflex.push_back(i);
+    const int scans = 4;
+    int bestI = -1, bestJ = -1, bestSize = 0;
+    for (int s = 0; s < scans && s < reflex.size(); s++)
+    {
+        int i = reflex[(long long)s * reflex.size() / min(scans, (int)reflex.size())];
+        for (int t = 0; t < n; t++)
+        {
+            int d = n / 2 + ((t % 2) ? (t + 1) / 2 : -(t / 2));
+            if (d < 2 || d > n - 2)
+                continue;
+            int j = (i + d) % n;
+            if (!isDiagonal(poly, i, j, o))
+                continue;
+            int size = min(d, n - d); // edges on the shorter side
+            if (size > bestSize)
+                bestI = i, bestJ = j, bestSize = size;
+            break;
+        }
+    }
+    if (bestI == -1)
+        return false;
+    cutPolygon(poly, bestI, bestJ, left, right);
+    return true;
+}
+
+/**
+ * @brief Decomposes one part of a split polygon and checks the result
+ *
+ * A part that #fun decomposes invalidly is split again and both halves are decomposed the same
+ * way, up to depth more times. Splitting is cheaper than retrying #fun on the whole part from
+ * other start vertices, since the halves cost about half as much each and usually succeed.
+ * A part that cannot be split is kept whole if it is a valid piece itself; sub-parts still invalid
+ * after that are handed back in rest rather than dropping the pieces found for their neighbours.
+ *
+ * @param part the sub-polygon
+ * @param res the pieces of the part, only pieces that pass #validate are added
+ * @param rest sub-parts of part that are not covered by res
+ * @param tol largest allowed concavity of a piece, passed on to #fun
+ * @param depth how many more times the part may be split
+ */
+void decomposePart(vector<Vertex *> &part, vector<vector<Vertex *> > &res, vector<vector<Vertex *> > &rest, double tol, int depth)
+{
+    DCEL sub;
+    sub.v = part;
+    vector<vector<Vertex *> > pieces;
+    fun(sub, pieces, tol);
+    if (validate(pieces, sub, tol).ok)
+    {
+        res.insert(res.end(), pieces.begin(), pieces.end());
+        return;
+    }
+
+    vector<Vertex *> left, right;
+    if (depth > 0 && splitPolygon(part, left, right))
+    {
+        decomposePart(left, res, rest, tol, depth - 1);
+        decomposePart(right, res, rest, tol, depth - 1);
+        return;
+    }
+    pieces.assign(1, part); // a part with no diagonal has no reflex vertex, it may be a piece itself
+    if (validate(pieces, sub, tol).ok)
+        res.push_back(part);
+    else
+        rest.push_back(part);
+}
+
+/**
+ * @brief Decomposes one large polygon on several threads
+ *
+ * The polygon is split along internal diagonals into up to k sub-polygons of similar size, the
+ * largest part that #splitPolygon can cut being split each time; fewer parts are used if no more
+ * cuts are found. Every sub-polygon is decomposed by #decomposePart on its own thread and the
+ * results are concatenated. The split diagonals become ordinary diagonals of the partition, so a
+ * following #merge with the original polygon removes those that are inessential.
+ *
+ * Sub-parts a thread could not decompose validly within 16 further splits are reported and split
+ * further on the calling thread, keeping every piece already found. Only if one of them still
+ * fails (#fun failing on a convex part, which cannot be cut) are the parallel pieces dropped and
+ * the whole polygon decomposed by #fun instead.
+ *
+ * @param poly The original polygon
+ * @param ans List of all the polygons after the partition process
+ * @param k number of sub-polygons (and threads)
+ * @param tol largest allowed concavity of a piece, passed on to #fun
+ */
+void funParallel(DCEL poly, vector<vector<Vertex *> > &ans, int k, double tol = 0)
+{
+    vector<vector<Vertex *> > parts(1, poly.v);
+    vector<bool> uncut(1, false); // parts #splitPolygon found no diagonal for
+    while (parts.size() < k)
+    {
+        int big = -1;
+        for (int i = 0; i < parts.size(); i++)
+            if (!uncut[i] && (big == -1 || parts[i].size() > parts[big].size()))
+                big = i;
+        if (big == -1)
+            break;
+        vector<Vertex *> left, right;
+        if (!splitPolygon(parts[big], left, right))
+        {
+            uncut[big] = true;
+            continue;
+        }
+        parts[big] = left;
+        parts.push_back(right);
+        uncut.push_back(false);
+    }
+    cout << "split into " << parts.size() << " sub-polygons";
+    if (parts.size() < k)
+        cout << ", no diagonal found for more";
+    cout << endl;
+
+    vector<vector<vector<Vertex *> > > res(parts.size()), rest(parts.size());
+    vector<thread> workers;
+    for (int i = 0; i < parts.size(); i++)
+    {
+        workers.push_back(thread([&parts, &res, &rest, i, tol]() {
+            decomposePart(parts[i], res[i], rest[i], tol, 16);
+        }));
+    }
+    for (int i = 0; i < workers.size(); i++)
+        workers[i].join();
+
+    for (int i = 0; i < parts.size(); i++)
+    {
+        if (rest[i].empty())
+            continue;
+        cout << "sub-polygon " << i << " left " << rest[i].size() << " sub-part(s) invalid after 16 splits, splitting them further on the calling thread" << endl;
+        vector<vector<Vertex *> > left;
+        for (int j = 0; j < rest[i].size(); j++)
+            decomposePart(rest[i][j], res[i], left, tol, rest[i][j].size());
+        if (!left.empty())
+        {
+            cout << "sub-polygon " << i << " has no valid decomposition, decomposing the whole polygon serially" << endl;
+            fun(poly, ans, tol);
+            return;
+        }
+    }
+    for (int i = 0; i < res.size(); i++)
+        ans.insert(ans.end(), res[i].begin(), res[i].end());
+}
+
+/**
+ * @brief checks in linear time if every edge of the polygon is horizontal or vertical
+ *
+ * @param poly the given polygon
+ *
+ * @return true if the polygon is rectilinear
+ */
+bool isRectilinear(vector<Vertex *> &poly)
+{
+    int n = poly.size();
+    if (n < 4)
+        return false;
+    for (int i = 0; i < n; i++)
+    {
+        Vertex *a = poly[i], *b = poly[(i + 1) % n];
+        if (samePoint(a, b) || (a->x != b->x && a->y != b->y))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief adds the rectangle [x1, x2] x [y1, y2] to ans with the orientation of the input
+ *
+ * Corners that are vertices of the input reuse them, the others are new vertices.
+ */
+void addRectangle(double x1, double x2, double y1, double y2, int o, map<pair<double, double>, Vertex *> &corners, vector<vector<Vertex *> > &ans)
+{
+    double cx[4] = {x1, x1, x2, x2}, cy[4] = {y1, y2, y2, y1}; // clockwise
+    vector<Vertex *> r;
+    for (int i = 0; i < 4; i++)
+    {
+        Vertex *&c = corners[make_pair(cx[i], cy[i])];
+        if (c == NULL)
+            c = new Vertex(cx[i], cy[i]);
+        r.push_back(c);
+    }
+    if (o > 0)
+        reverse(r.begin(), r.end());
+    ans.push_back(r);
+}
+
+/**
+ * @brief Partitions a rectilinear polygon into rectangles with a sweep line in O(n log n)
+ *
+ * A horizontal line sweeps upwards over the horizontal edges. The part of the line inside the
+ * polygon is a set of disjoint x intervals, each one the bottom of a rectangle that is still
+ * growing. Every edge toggles the inside on its span: the intervals it touches are closed into
+ * rectangles and the toggled intervals are opened again at its height. This cuts the polygon
+ * along a horizontal chord from every reflex vertex.
+ *
+ * @param poly the given polygon, must be rectilinear
+ * @param ans the rectangles are appended here
+ */
+void rectangles(vector<Vertex *> &poly, vector<vector<Vertex *> > &ans)
+{
+    int n = poly.size();
+    vector<double> px(n), py(n);
+    map<pair<double, double>, Vertex *> corners;
+    vector<pair<double, pair<double, double> > > edges; // (y, (left x, right x))
+    for (int i = 0; i < n; i++)
+    {
+        Vertex *a = poly[i], *b = poly[(i + 1) % n];
+        px[i] = a->x;
+        py[i] = a->y;
+        corners[make_pair(a->x, a->y)] = a;
+        if (a->y == b->y && a->x != b->x)
+            edges.push_back(make_pair(a->y, make_pair(min(a->x, b->x), max(a->x, b->x))));
+    }
+    int o = signedArea2(px.data(), py.data(), n) > 0 ? 1 : -1;
+    sort(edges.begin(), edges.end());
+
+    map<double, pair<double, double> > open; // left x -> (right x, bottom y)
+    for (int e = 0; e < edges.size(); e++)
+    {
+        double y = edges[e].first, a = edges[e].second.first, b = edges[e].second.second;
+
+        // the open intervals overlapping or touching [a, b]
+        vector<pair<double, double> > touched;
+        map<double, pair<double, double> >::iterator it = open.upper_bound(b);
+        while (it != open.begin() && prev(it)->second.first >= a)
+        {
+            --it;
+            touched.push_back(make_pair(it->first, it->second.first));
+            if (y > it->second.second)
+                addRectangle(it->first, it->second.first, it->second.second, y, o, corners, ans);
+            it = open.erase(it);
+        }
+
+        // inside after the edge = inside before xor [a, b]
+        vector<double> xs;
+        xs.push_back(a);
+        xs.push_back(b);
+        for (int i = 0; i < touched.size(); i++)
+        {
+            xs.push_back(touched[i].first);
+            xs.push_back(touched[i].second);
+        }
+        sort(xs.begin(), xs.end());
+        xs.erase(unique(xs.begin(), xs.end()), xs.end());
+        double from = 0;
+        bool inside = false;
+        for (int i = 0; i + 1 < xs.size(); i++)
+        {
+            double mid = (xs[i] + xs[i + 1]) / 2;
+            bool before = false;
+            for (int j = 0; j < touched.size(); j++)
+                if (touched[j].first <= mid && mid <= touched[j].second)
+                    before = true;
+            bool now = before != (a <= mid && mid <= b);
+            if (now && !inside)
+                from = xs[i];
+            if (!now && inside)
+                open[from] = make_pair(xs[i], y);
+            inside = now;
+        }
+        if (inside)
+            open[from] = make_pair(xs.back(), y);
+    }
+}
+
+/**
+ * @brief a horizontal or vertical chord joining two reflex vertices of a rectilinear polygon
+ */
+class Chord
+{
+public:
+    int u, v;          // indices of the end points in the polygon
+    double lo, hi, at; // extent along the chord and its fixed co-ordinate
+};
+
+/**
+ * @brief Partitions a rectilinear polygon into the minimum number of rectangles
+ *
+ * Chords joining two reflex vertices each remove one rectangle from the count. The largest set of
+ * such chords that do not intersect is a maximum independent set of the bipartite intersection
+ * graph of horizontal and vertical chords, found from a maximum matching (Kuhn) by Koenig's
+ * theorem. The polygon is cut along those chords and each part is finished by #rectangles,
+ * which gives r - L + 1 rectangles for r reflex vertices and L chords.
+ *
+ * Finding the chords takes O(n) per candidate and the matching O(V E) on the chord graph, so
+ * this is slower than #rectangles on polygons with many aligned reflex vertices.
+ *
+ * @param poly the given polygon, must be rectilinear
+ * @param ans the rectangles are appended here
+ */
+void minimalRectangles(vector<Vertex *> &poly, vector<vector<Vertex *> > &ans)
+{
+    int n = poly.size();
+    vector<double> px(n), py(n);
+    for (int i = 0; i < n; i++)
+    {
+        px[i] = poly[i]->x;
+        py[i] = poly[i]->y;
+    }
+    int o = signedArea2(px.data(), py.data(), n) > 0 ? 1 : -1;
+    vector<bool> reflex(n);
+    for (int i = 0; i < n; i++)
+        reflex[i] = o * orient(poly[(i + n - 1) % n], poly[i], poly[(i + 1) % n]) < 0;
+
+    // candidate chords join reflex vertices that are next to each other on a line
+    vector<Chord> hor, ver;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        map<double, vector<pair<double, int> > > lines;
+        for (int i = 0; i < n; i++)
+        {
+            if (pass == 0)
+                lines[py[i]].push_back(make_pair(px[i], i));
+            else
+                lines[px[i]].push_back(make_pair(py[i], i));
+        }
+        for (auto &l : lines)
+        {
+            sort(l.second.begin(), l.second.end());
+            for (int k = 0; k + 1 < l.second.size(); k++)
+            {
+                int u = l.second[k].second, v = l.second[k + 1].second;
+                if (!reflex[u] || !reflex[v] || !isDiagonal(poly, u, v, o))
+                    continue;
+                Chord c;
+                c.u = u;
+                c.v = v;
+                c.lo = l.second[k].first;
+                c.hi = l.second[k + 1].first;
+                c.at = l.first;
+                (pass == 0 ? hor : ver).push_back(c);
+            }
+        }
+    }
+
+    // intersection graph, horizontal chords on the left
+    vector<vector<int> > adj(hor.size());
+    for (int i = 0; i < hor.size(); i++)
+        for (int j = 0; j < ver.size(); j++)
+            if (hor[i].lo <= ver[j].at && ver[j].at <= hor[i].hi && ver[j].lo <= hor[i].at && hor[i].at <= ver[j].hi)
+                adj[i].push_back(j);
+
+    vector<int> matchL(hor.size(), -1), matchR(ver.size(), -1);
+    for (int i = 0; i < hor.size(); i++)
+    {
+        vector<bool> seen(ver.size(), false);
+        // augmenting path search, iterative so long chains do not overflow the stack
+        vector<pair<int, int> > path; // (left vertex, next edge to try)
+        path.push_back(make_pair(i, 0));
+        while (path.size() > 0)
+        {
+            int l = path.back().first;
+            if (path.back().second == adj[l].size())
+            {
+                path.pop_back();
+                continue;
+            }
+            int r = adj[l][path.back().second++];
+            if (seen[r])
+                continue;
+            seen[r] = true;
+            if (matchR[r] == -1)
+            {
+                // flip the path
+                for (int k = path.size() - 1; k >= 0; k--)
+                {
+                    int pl = path[k].first, pr = adj[pl][path[k].second - 1];
+                    matchL[pl] = pr;
+                    matchR[pr] = pl;
+                }
+                break;
+            }
+            path.push_back(make_pair(matchR[r], 0));
+        }
+    }
+
+    // Koenig: vertices reachable from free left vertices by alternating paths
+    vector<bool> zl(hor.size(), false), zr(ver.size(), false);
+    vector<int> q;
+    for (int i = 0; i < hor.size(); i++)
+        if (matchL[i] == -1)
+        {
+            zl[i] = true;
+            q.push_back(i);
+        }
+    for (int k = 0; k < q.size(); k++)
+        for (int j = 0; j < adj[q[k]].size(); j++)
+        {
+            int r = adj[q[k]][j];
+            if (zr[r])
+                continue;
+            zr[r] = true;
+            if (matchR[r] != -1 && !zl[matchR[r]])
+            {
+                zl[matchR[r]] = true;
+                q.push_back(matchR[r]);
+            }
+        }
+    vector<Chord> cuts;
+    for (int i = 0; i < hor.size(); i++)
+        if (zl[i])
+            cuts.push_back(hor[i]);
+    for (int j = 0; j < ver.size(); j++)
+        if (!zr[j])
+            cuts.push_back(ver[j]);
+
+    // cut along the chosen chords, each one lies inside exactly one part
+    vector<vector<Vertex *> > parts(1, poly);
+    unordered_map<Vertex *, int> owner;
+    for (int i = 0; i < n; i++)
+        owner[poly[i]] = 0;
+    for (int c = 0; c < cuts.size(); c++)
+    {
+        Vertex *u = poly[cuts[c].u], *v = poly[cuts[c].v];
+        int p = owner[u];
+        vector<Vertex *> &part = parts[p];
+        int iu = find(part.begin(), part.end(), u) - part.begin();
+        int iv = find(part.begin(), part.end(), v) - part.begin();
+        int m = part.size();
+        vector<Vertex *> left, right;
+        for (int k = iu; k != iv; k = (k + 1) % m)
+            left.push_back(part[k]);
+        left.push_back(v);
+        for (int k = iv; k != iu; k = (k + 1) % m)
+            right.push_back(part[k]);
+        right.push_back(u);
+        parts[p] = left;
+        parts.push_back(right);
+        for (int k = 0; k < right.size(); k++)
+            owner[right[k]] = parts.size() - 1;
+    }
+
+    for (int i = 0; i < parts.size(); i++)
+        rectangles(parts[i], ans);
+}
+
+int main(int argc, char *argv[])
+{
+    // --simplify <tol> merges vertices closer than tol and drops exactly collinear and spike vertices
+    // --dp <tol> additionally runs Douglas-Peucker with maximum deviation tol
+    // --threads <k> splits the polygon into k parts that are decomposed in parallel
+    // --min-rectangles partitions rectilinear input into the fewest rectangles
+    // --concavity <tol> accepts pieces that are at most tol away from their convex hull
+    // --stream writes every piece to Points.txt as soon as no more merging can change it
+    double simplifyTol = -1, dpTol = -1, concavityTol = 0;
+    int threads = 1;
+    bool minRectangles = false, stream = false;
+    for (int i = 1; i < argc; i++)
+    {
+        string opt = argv[i];
+        if (opt == "--simplify" && i + 1 < argc)
+            simplifyTol = atof(argv[++i]);
+        else if (opt == "--dp" && i + 1 < argc)
+            dpTol = atof(argv[++i]);
+        else if (opt == "--threads" && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (opt == "--concavity" && i + 1 < argc)
+            concavityTol = atof(argv[++i]);
+        else if (opt == "--min-rectangles")
+            minRectangles = true;
+        else if (opt == "--stream")
+            stream = true;
+    }
+    if (stream && (threads > 1 || minRectangles))
+    {
+        cerr << "--stream cannot be combined with --threads or --min-rectangles" << endl;
+        return 1;
+    }
+
+    fstream file("inp.txt");
+
+    int n;
+    file >> n;
+    DCEL poly;
+    vector<Vertex *> inp;
+    for (int i = 0; i < n; i++)
+    {
+        double x, y;
+        file >> x >> y;
+        inp.push_back(new Vertex(x, y));
+    }
+
+    // ids[i] is the index in inp.txt of vertex i of the polygon that is decomposed
+    vector<int> ids;
+    for (int i = 0; i < n; i++)
+        ids.push_back(i);
+    if (simplifyTol >= 0 || dpTol >= 0)
+    {
+        vector<int> kept;
+        inp = simplify(inp, max(simplifyTol, 0.0), kept);
+        for (int i = 0; i < kept.size(); i++)
+            kept[i] = ids[kept[i]];
+        ids = kept;
+        if (dpTol > 0)
+        {
+            inp = simplifyDP(inp, dpTol, kept);
+            for (int i = 0; i < kept.size(); i++)
+                kept[i] = ids[kept[i]];
+            ids = kept;
+        }
+        cout << "simplified " << n << " vertices to " << inp.size() << endl;
+        n = inp.size();
+
+        ofstream idfile("Ids.txt");
+        for (int i = 0; i < n; i++)
+            idfile << inp[i]->x << " " << inp[i]->y << " " << ids[i] << endl;
+        idfile.close();
+    }
+    for (int i = 0; i < n; i++)
+        poly.addVertex(inp[i]->x, inp[i]->y);
+
+    for (int i = 1; i < n; i++)
+    {
+        poly.addEdge(poly.v[i - 1]->x, poly.v[i - 1]->y, poly.v[i]->x, poly.v[i]->y);
+    }
+    poly.addEdge(poly.v[n - 1]->x, poly.v[n - 1]->y, poly.v[0]->x, poly.v[0]->y);
+
+    file.close();
+    vector<vector<Vertex *> > ans;
+
+    if (stream && isRectilinear(poly.v))
+        cout << "rectilinear input is cut into rectangles, which are not streamed" << endl;
+    else if (stream)
+    {
+        // pieces leave as soon as they are final, so nothing is kept for validate and exportPieces
+        ofstream myfile("Points.txt");
+        int count = 0;
+        StreamMerger merger(poly.v, [&myfile, &count](vector<Vertex *> &piece) {
+            for (int j = 0; j < piece.size(); j++)
+                myfile << piece[j]->x << " " << piece[j]->y << " " << piece[(j + 1) % piece.size()]->x << " " << piece[(j + 1) % piece.size()]->y << endl;
+            count++;
+        }, concavityTol);
+        funStream(poly, [&merger](vector<Vertex *> &piece) { merger.add(piece); }, concavityTol);
+        merger.finish();
+        myfile.close();
+        cout << count << " pieces streamed" << endl;
+        printPredicateStats();
+        return 0;
+    }
+
+    // axis aligned outlines are cut into rectangles, everything else goes through fun and merge
+    bool rectilinear = isRectilinear(poly.v);
+    if (rectilinear && minRectangles)
+        minimalRectangles(poly.v, ans);
+    else if (rectilinear)
+        rectangles(poly.v, ans);
+    else if (threads > 1)
+        funParallel(poly, ans, threads, concavityTol);
+    else
+        fun(poly, ans, concavityTol);
+    ofstream myfile;
+    myfile.open("Vertexs.txt");
+    for (int i = 0; i < ans.size(); i++)
+    {
+        cout << "vector" << endl;
+        for (int j = 0; j < ans[i].size(); j++)
+        {
+            cout << ans[i][j]->x << " " << ans[i][j]->y << endl;
+        }
+    }
+
+    for (int i = 0; i < ans.size(); i++)
+    {
+        for (int j = 0; j < ans[i].size(); j++)
+        {
+            myfile << ans[i][j]->x << " " << ans[i][j]->y << " " << ans[i][(j + 1) % ans[i].size()]->x << " " << ans[i][(j + 1) % ans[i].size()]->y << endl;
+        }
+    }
+
+    // set<pair<Vertex*, Vertex*>> added;
+
+    // rectangles have corners that are not input vertices, which #merge and #validate do not allow
+    if (!rectilinear)
+    {
+        merge(ans, poly, concavityTol);
+        printReport(validate(ans, poly, concavityTol));
+    }
+    else
+        cout << ans.size() << " rectangles" << endl;
 
-     merge(ans, poly);
+    printPredicateStats();
+    exportPieces(ans, "Pieces.bin");
     return 0;
 }
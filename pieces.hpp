@@ -0,0 +1,93 @@
+    #ifndef PIECES_HPP
+    #define PIECES_HPP
+
+    #include <stdint.h>
+    #include <stddef.h>
+    #include <string.h>
+
+    /** @file */
+
+    /**
+     * @brief header of the collision export written by #exportPieces
+     *
+     * The file is one block that can be mmap'ed and used in place. Every section starts at a
+     * multiple of #PIECES_ALIGN bytes from the start of the file and the offsets below are in bytes
+     * from the start of the file. All values are little-endian, co-ordinates are IEEE doubles.
+     *
+     * Sections:
+     * - ranges: #PieceRange[pieceCount], the vertices of piece i are first .. first+count-1
+     * - x, y: double[vertexCount], vertex co-ordinates, pieces stored one after another
+     * - nx, ny: double[vertexCount], unit outward normal of the edge from vertex j to the next vertex of the same piece
+     * - aabb: #PieceAABB[pieceCount], bounding box of every piece
+     *
+     * The layout only changes together with #PIECES_VERSION.
+     */
+    struct PiecesHeader
+    {
+        char magic[8];        // "CVXPIECE"
+        uint32_t version;     // PIECES_VERSION
+        uint32_t headerSize;  // sizeof(PiecesHeader)
+        uint64_t pieceCount;
+        uint64_t vertexCount;
+        uint64_t rangesOffset;
+        uint64_t xOffset, yOffset;
+        uint64_t nxOffset, nyOffset;
+        uint64_t aabbOffset;
+        uint64_t fileSize;
+        uint64_t reserved[5];
+    };
+
+    /**
+     * @brief position of one piece in the vertex arrays
+     */
+    struct PieceRange
+    {
+        uint32_t first;
+        uint32_t count;
+    };
+
+    /**
+     * @brief axis aligned bounding box of one piece
+     */
+    struct PieceAABB
+    {
+        double minx, miny, maxx, maxy;
+    };
+
+    static const uint32_t PIECES_VERSION = 1;
+    static const uint64_t PIECES_ALIGN = 64;
+
+    static_assert(sizeof(PiecesHeader) == 128, "PiecesHeader is part of the file format");
+    static_assert(offsetof(PiecesHeader, pieceCount) == 16, "PiecesHeader is part of the file format");
+    static_assert(offsetof(PiecesHeader, fileSize) == 80, "PiecesHeader is part of the file format");
+    static_assert(sizeof(PieceRange) == 8, "PieceRange is part of the file format");
+    static_assert(sizeof(PieceAABB) == 32, "PieceAABB is part of the file format");
+
+    /**
+     * @brief checks that a mapped block holds a collision export this header can read
+     *
+     * @param base start of the mapped file
+     * @param size size of the mapped file in bytes
+     *
+     * @return the header, or NULL if the block is not a valid export
+     */
+    inline const PiecesHeader *piecesView(const void *base, uint64_t size)
+    {
+        const PiecesHeader *h = (const PiecesHeader *)base;
+        if (size < sizeof(PiecesHeader) || memcmp(h->magic, "CVXPIECE", 8) != 0)
+            return NULL;
+        if (h->version != PIECES_VERSION || h->headerSize != sizeof(PiecesHeader) || h->fileSize > size)
+            return NULL;
+        return h;
+    }
+
+    /**
+     * @brief typed pointer to a section of a mapped export
+     */
+    template <class T>
+    inline const T *piecesSection(const PiecesHeader *h, uint64_t offset)
+    {
+        return (const T *)((const char *)h + offset);
+    }
+
+    #endif
@@ -0,0 +1,140 @@
+    #ifndef PREDICATES_HPP
+    #define PREDICATES_HPP
+
+    #include <math.h>
+    #include <atomic>
+    #include <vector>
+
+    /** @file */
+
+    /**
+     * @brief counts of orientation tests, kept per thread and added to #predicateTotals when the thread ends
+     */
+    class PredicateCounter
+    {
+    public:
+        unsigned long long calls = 0, exact = 0;
+        ~PredicateCounter();
+    };
+
+    /**
+     * @brief totals of the counters of all threads that have finished
+     */
+    class PredicateTotals
+    {
+    public:
+        std::atomic<unsigned long long> calls{0}, exact{0};
+    };
+
+    inline PredicateTotals predicateTotals;
+    inline thread_local PredicateCounter predicateCounter;
+
+    inline PredicateCounter::~PredicateCounter()
+    {
+        predicateTotals.calls += calls;
+        predicateTotals.exact += exact;
+    }
+
+    // relative error bound of the floating point determinant, Shewchuk's ccwerrboundA
+    static const double ORIENT_EPS = 1.1102230246251565e-16; // 2^-53
+    static const double ORIENT_ERRBOUND = (3.0 + 16.0 * ORIENT_EPS) * ORIENT_EPS;
+
+    /**
+     * @brief x = a + b exactly, with x the rounded sum and y the rounding error
+     */
+    inline void twoSum(double a, double b, double &x, double &y)
+    {
+        x = a + b;
+        double bv = x - a;
+        double av = x - bv;
+        y = (a - av) + (b - bv);
+    }
+
+    /**
+     * @brief adds b to the non-overlapping expansion e, keeping it sorted by increasing magnitude
+     */
+    inline void growExpansion(std::vector<double> &e, double b)
+    {
+        double q = b;
+        for (int i = 0; i < e.size(); i++)
+        {
+            double h;
+            twoSum(q, e[i], q, h);
+            e[i] = h;
+        }
+        e.push_back(q);
+    }
+
+    /**
+     * @brief exact orientation of c relative to the line ab using expansion arithmetic
+     *
+     * The determinant is expanded into six products, each one split exactly into two doubles
+     * with fma, and all twelve terms are summed as an expansion.
+     *
+     * @return a value with the sign of the exact determinant, close to its magnitude
+     */
+    inline double orient2dExact(double ax, double ay, double bx, double by, double cx, double cy)
+    {
+        double p[6][2] = {{ax, by}, {-ax, cy}, {-cx, by}, {-ay, bx}, {ay, cx}, {cy, bx}};
+        std::vector<double> e;
+        for (int i = 0; i < 6; i++)
+        {
+            double hi = p[i][0] * p[i][1];
+            double lo = fma(p[i][0], p[i][1], -hi);
+            growExpansion(e, lo);
+            growExpansion(e, hi);
+        }
+        // the largest component decides the sign
+        for (int i = e.size() - 1; i >= 0; i--)
+            if (e[i] != 0)
+                return e[i];
+        return 0;
+    }
+
+    /**
+     * @brief Adaptive orientation test of point c relative to the directed line ab
+     *
+     * The determinant is first evaluated with doubles. If it is larger than the error bound of
+     * that evaluation its sign is certain; otherwise it is recomputed exactly with
+     * #orient2dExact. Calls and exact fallbacks are counted in #predicateCounter.
+     *
+     * @return positive if c is to the left of ab, negative if to the right, 0 if collinear
+     */
+    inline double orient2d(double ax, double ay, double bx, double by, double cx, double cy)
+    {
+        predicateCounter.calls++;
+        double detleft = (ax - cx) * (by - cy);
+        double detright = (ay - cy) * (bx - cx);
+        double det = detleft - detright;
+        double detsum;
+        if (detleft > 0)
+        {
+            if (detright <= 0)
+                return det;
+            detsum = detleft + detright;
+        }
+        else if (detleft < 0)
+        {
+            if (detright >= 0)
+                return det;
+            detsum = -detleft - detright;
+        }
+        else
+            return det;
+
+        if (det >= ORIENT_ERRBOUND * detsum || -det >= ORIENT_ERRBOUND * detsum)
+            return det;
+        predicateCounter.exact++;
+        return orient2dExact(ax, ay, bx, by, cx, cy);
+    }
+
+    /**
+     * @brief number of orientation tests so far, and how many needed exact arithmetic
+     */
+    inline void predicateStats(unsigned long long &calls, unsigned long long &exact)
+    {
+        calls = predicateTotals.calls + predicateCounter.calls;
+        exact = predicateTotals.exact + predicateCounter.exact;
+    }
+
+    #endif